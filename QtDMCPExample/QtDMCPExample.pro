@@ -15,15 +15,19 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     qdmcpconnection.cpp \
+    qdmcpreadplan.cpp \
     qdmcpreadrequest.cpp \
     qdmcprequest.cpp \
+    qdmcptagdatabase.cpp \
     qdmcpwriterequest.cpp
 
 HEADERS += \
     mainwindow.h \
     qdmcpconnection.h \
+    qdmcpreadplan.h \
     qdmcpreadrequest.h \
     qdmcprequest.h \
+    qdmcptagdatabase.h \
     qdmcpwriterequest.h
 
 FORMS += \
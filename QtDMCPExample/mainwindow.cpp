@@ -2,6 +2,7 @@
 #include "ui_mainwindow.h"
 
 #include <stdio.h>
+#include <QCoreApplication>
 #include <QDebug>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -15,7 +16,9 @@ MainWindow::MainWindow(QWidget *parent)
     // Set up UI signals
     connect(m_ui->connectButton, &QPushButton::clicked, this, &MainWindow::tryToConnect);
     connect(m_ui->sendDataButton, &QPushButton::clicked, this, &MainWindow::sendWriteRequest);
+    connect(m_ui->sendDataField, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::sendStreamWriteRequest);
     connect(m_ui->receiveDataButton, &QPushButton::clicked, this, &MainWindow::sendReadRequest);
+    connect(m_ui->readTagsButton, &QPushButton::clicked, this, &MainWindow::sendTagReadRequest);
 
     // Set up RMC signals
     connect(m_connection, &QDmcpConnection::connected, this, &MainWindow::onConnected);
@@ -23,11 +26,39 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_connection, &QDmcpConnection::socketErrorOccurred, this, &MainWindow::onSocketErrorOccurred);
     connect(m_connection, &QDmcpConnection::writeResponse, this, &MainWindow::onWriteResponse);
     connect(m_connection, &QDmcpConnection::readResponse, this, &MainWindow::onReadResponse);
+    connect(m_connection, &QDmcpConnection::readPlanResponse, this, &MainWindow::onReadPlanResponse);
+    connect(m_connection, &QDmcpConnection::streamWriteFailed, this, &MainWindow::onStreamWriteFailed);
+    connect(m_connection, &QDmcpConnection::streamWriteCounts, this, &MainWindow::onStreamWriteCounts);
+
+    // Load the named tags, if a tag table was deployed with the application
+    this->loadTagDatabase();
 
     // Initialize program to the "disconnected" state
     this->onDisconnected();
 }
 
+void MainWindow::loadTagDatabase() {
+    /// <summary>
+    /// Loads the tag table (tags.csv) from the application's directory, so that registers can be
+    /// referred to by name. A missing table is not an error; a malformed one is reported.
+    /// </summary>
+    QString fileName = QCoreApplication::applicationDirPath() + "/tags.csv";
+    if (!QFile::exists(fileName)) {
+        return;
+    }
+
+    if (m_tagDatabase.load(fileName)) {
+        m_ui->statusBar->showMessage(tr("Loaded %1 tags").arg(m_tagDatabase.count()));
+    } else {
+        QMessageBox errorBox = QMessageBox(
+            QMessageBox::Icon::Warning,
+            QString("Couldn't load tag table"),
+            QString("Error: ") + m_tagDatabase.errorString()
+        );
+        errorBox.exec();
+    }
+}
+
 void MainWindow::tryToConnect() {
     if (m_connection->state() != QTcpSocket::ConnectedState) {
         m_ui->ipAddressField->setEnabled(false);
@@ -55,9 +86,16 @@ void MainWindow::onConnected() {
 
     m_ui->sendDataField->setEnabled(true);
     m_ui->sendDataButton->setEnabled(true);
+    m_ui->streamDataCheckBox->setEnabled(true);
 
     m_ui->receivedDataField->setEnabled(true);
     m_ui->receiveDataButton->setEnabled(true);
+
+    // Tags can only be read if a tag table was loaded.
+    bool hasTags = m_tagDatabase.count() > 0;
+    m_ui->tagNamesField->setEnabled(hasTags);
+    m_ui->readTagsButton->setEnabled(hasTags);
+    m_ui->tagValuesField->setEnabled(hasTags);
 }
 
 void MainWindow::onDisconnected() {
@@ -76,9 +114,14 @@ void MainWindow::onDisconnected() {
 
     m_ui->sendDataField->setEnabled(false);
     m_ui->sendDataButton->setEnabled(false);
+    m_ui->streamDataCheckBox->setEnabled(false);
 
     m_ui->receivedDataField->setEnabled(false);
     m_ui->receiveDataButton->setEnabled(false);
+
+    m_ui->tagNamesField->setEnabled(false);
+    m_ui->readTagsButton->setEnabled(false);
+    m_ui->tagValuesField->setEnabled(false);
 }
 
 void MainWindow::onSocketErrorOccurred(QAbstractSocket::SocketError) {
@@ -130,6 +173,25 @@ void MainWindow::sendWriteRequest() {
     m_connection->sendRequest(request);
 }
 
+void MainWindow::sendStreamWriteRequest() {
+    /// <summary>
+    /// Run whenever the value to set is committed (keyboard tracking is off, so partially typed values
+    /// are not). If streaming is turned on, the new value is written to the RMC straight away, without
+    /// waiting for or displaying a response to each write.
+    /// </summary>
+    if (!m_ui->streamDataCheckBox->isChecked() || m_connection->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    QDmcpWriteRequest request;
+    request.setStartingAddress(m_ui->addressFileField->value(), m_ui->addressElementField->value());
+    request.setValues(QVector<QVariant> { QVariant(static_cast<float>(m_ui->sendDataField->value())) });
+
+    // Send the write request as part of stream 0. Only failures are reported individually, in
+    // onStreamWriteFailed(); otherwise we'll get periodic totals in onStreamWriteCounts().
+    m_connection->sendStreamWrite(request, 0);
+}
+
 void MainWindow::sendReadRequest() {
     /// <summary>
     /// Requests the RMC to send the data at a given address.
@@ -153,6 +215,39 @@ void MainWindow::sendReadRequest() {
     m_connection->sendRequest(request);
 }
 
+void MainWindow::sendTagReadRequest() {
+    /// <summary>
+    /// Requests the RMC to send the data for the comma-separated tag names entered by the user.
+    /// </summary>
+
+    // Compile the tag names into a read plan, unless they are the same as last time, in which
+    // case the plan that was already compiled can be sent again as-is.
+    QString text = m_ui->tagNamesField->text();
+    if (text != m_tagReadPlanText) {
+        QStringList tagNames;
+        for (const QString& name : text.split(',')) {
+            if (!name.trimmed().isEmpty()) {
+                tagNames.append(name.trimmed());
+            }
+        }
+
+        m_tagReadPlan = m_tagDatabase.compileReadPlan(tagNames);
+        m_tagReadPlanText = text;
+    }
+
+    // Send the read plan to the RMC. If the RMC responds, we'll handle it in onReadPlanResponse().
+    if (!m_connection->sendReadPlan(m_tagReadPlan)) {
+        QMessageBox box = QMessageBox(
+            QMessageBox::Icon::Critical,
+            QString("Couldn't read tags"),
+            m_tagReadPlan.unknownTags().isEmpty()
+                ? QString("Error: No tags were entered.")
+                : QString("Error: Unknown tags: ") + m_tagReadPlan.unknownTags().join(", ")
+        );
+        box.exec();
+    }
+}
+
 void MainWindow::onWriteResponse(QDmcpWriteRequest *, QDmcpConnection::ResponseCode responseCode) {
     /// <summary>
     /// Run when the RMC has responded to a write request.
@@ -183,6 +278,9 @@ void MainWindow::onWriteResponse(QDmcpWriteRequest *, QDmcpConnection::ResponseC
     case QDmcpConnection::ResponseCode::InvalidAddress:
         box.setText("Error: Address was invalid.");
         break;
+    case QDmcpConnection::ResponseCode::ConnectionLost:
+        box.setText("Error: Connection was lost.");
+        break;
     }
 
     // Display the message box.
@@ -213,6 +311,9 @@ void MainWindow::onReadResponse(QDmcpReadRequest *, QSharedPointer<QVector<QVari
         case QDmcpConnection::ResponseCode::InvalidAddress:
             box.setText("Error: Address was invalid.");
             break;
+        case QDmcpConnection::ResponseCode::ConnectionLost:
+            box.setText("Error: Connection was lost.");
+            break;
         default:
             break;
         }
@@ -239,6 +340,79 @@ void MainWindow::onReadResponse(QDmcpReadRequest *, QSharedPointer<QVector<QVari
     }
 }
 
+void MainWindow::onReadPlanResponse(QDmcpReadPlan plan, QVariant, QSharedPointer<QVector<QVariant>> values, QDmcpConnection::ResponseCode responseCode) {
+    /// <summary>
+    /// Run when the RMC has responded to every request in a tag read plan.
+    /// </summary>
+    /// <param name="plan">The read plan that was responded to.</param>
+    /// <param name="associatedData">The data the plan was sent with.</param>
+    /// <param name="values">The values retrieved from the RMC, one per tag in the plan.</param>
+    /// <param name="responseCode">The response code returned by the RMC.</param>
+
+    // A plan cut short by a disconnection needs no message of its own; the UI has already been
+    // returned to the "disconnected" state.
+    if (responseCode == QDmcpConnection::ResponseCode::ConnectionLost) {
+        return;
+    }
+
+    // Handle the various error response codes from the RMC.
+    if (responseCode != QDmcpConnection::ResponseCode::Success) {
+        QMessageBox box = QMessageBox();
+        box.setIcon(QMessageBox::Icon::Critical);
+
+        switch (responseCode) {
+        case QDmcpConnection::ResponseCode::Malformed:
+            box.setText("Error: Request was malformed.");
+            break;
+        case QDmcpConnection::ResponseCode::TooLong:
+            box.setText("Error: Request was too long.");
+            break;
+        case QDmcpConnection::ResponseCode::InvalidAddress:
+            box.setText("Error: Address was invalid.");
+            break;
+        default:
+            break;
+        }
+
+        box.exec();
+        return;
+    }
+
+    // Display each tag alongside its value.
+    QStringList tagNames = plan.tagNames();
+    QStringList tagValues;
+    for (int i = 0; i < tagNames.count(); i++) {
+        tagValues.append(tagNames.at(i) + " = " + values->at(i).toString());
+    }
+    m_ui->tagValuesField->setText(tagValues.join(", "));
+}
+
+void MainWindow::onStreamWriteFailed(quint16 streamID, quint16 file, quint16 element, QDmcpConnection::ResponseCode responseCode) {
+    /// <summary>
+    /// Run when the RMC has rejected a streamed write.
+    /// </summary>
+    /// <param name="streamID">The stream the write was sent under.</param>
+    /// <param name="file">The file of the address that was written to.</param>
+    /// <param name="element">The element of the address that was written to.</param>
+    /// <param name="responseCode">The response code returned by the RMC.</param>
+
+    // Streamed writes can fail at a high rate, so report them in the status bar rather than
+    // in a message box that would have to be dismissed for each one.
+    m_ui->statusBar->showMessage(tr("Stream %1: write to %2:%3 failed (code %4)")
+                                 .arg(streamID).arg(file).arg(element).arg(responseCode));
+}
+
+void MainWindow::onStreamWriteCounts(quint16 streamID, quint32 successes, quint32 failures) {
+    /// <summary>
+    /// Run periodically with the acknowledgements received for a stream of writes.
+    /// </summary>
+    /// <param name="streamID">The stream the counts are for.</param>
+    /// <param name="successes">The number of writes acknowledged successfully since the last report.</param>
+    /// <param name="failures">The number of writes rejected since the last report.</param>
+    m_ui->statusBar->showMessage(tr("Stream %1: %2 writes succeeded, %3 failed")
+                                 .arg(streamID).arg(successes).arg(failures));
+}
+
 MainWindow::~MainWindow()
 {
     delete m_ui;
@@ -4,6 +4,7 @@
 #include "qdmcpconnection.h"
 #include "qdmcpwriterequest.h"
 #include "qdmcpreadrequest.h"
+#include "qdmcptagdatabase.h"
 
 #include <QMainWindow>
 
@@ -32,13 +33,26 @@ public slots:
     void onSocketErrorOccurred(QAbstractSocket::SocketError error);
 
     void sendWriteRequest();
+    void sendStreamWriteRequest();
     void sendReadRequest();
+    void sendTagReadRequest();
 
     void onWriteResponse(QDmcpWriteRequest *request, QDmcpConnection::ResponseCode responseCode);
     void onReadResponse(QDmcpReadRequest *request, QSharedPointer<QVector<QVariant>> values, QDmcpConnection::ResponseCode responseCode);
+    void onReadPlanResponse(QDmcpReadPlan plan, QVariant associatedData, QSharedPointer<QVector<QVariant>> values, QDmcpConnection::ResponseCode responseCode);
+
+    void onStreamWriteFailed(quint16 streamID, quint16 file, quint16 element, QDmcpConnection::ResponseCode responseCode);
+    void onStreamWriteCounts(quint16 streamID, quint32 successes, quint32 failures);
 
 private:
     Ui::MainWindow *m_ui;
     QDmcpConnection* m_connection;
+    QDmcpTagDatabase m_tagDatabase;
+
+    // The plan for the tags last read, kept so that reading the same tags again doesn't recompile it.
+    QString m_tagReadPlanText;
+    QDmcpReadPlan m_tagReadPlan;
+
+    void loadTagDatabase();
 };
 #endif // MAINWINDOW_H
@@ -1,7 +1,8 @@
 #include "qdmcpconnection.h"
 #include <QFile>
+#include <QtEndian>
 
-QDmcpConnection::QDmcpConnection(QObject *parent) : QObject(parent), m_socket(new QTcpSocket(this))
+QDmcpConnection::QDmcpConnection(QObject *parent) : QObject(parent), m_socket(new QTcpSocket(this)), m_streamReportTimer(new QTimer(this))
 {
     // Set up data stream
     m_dataStream.setDevice(m_socket);
@@ -13,6 +14,10 @@ QDmcpConnection::QDmcpConnection(QObject *parent) : QObject(parent), m_socket(ne
     connect(m_socket, &QTcpSocket::disconnected, this, &QDmcpConnection::onDisconnected);
     connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, &QDmcpConnection::onError);
     connect(m_socket, &QTcpSocket::readyRead, this, &QDmcpConnection::onDataReceived);
+
+    // Set up periodic reporting of streamed write acknowledgements
+    m_streamReportTimer->setInterval(1000);
+    connect(m_streamReportTimer, &QTimer::timeout, this, &QDmcpConnection::onStreamReportTimeout);
 }
 
 void QDmcpConnection::connectToRMC(QString hostName, quint16 port)
@@ -42,11 +47,84 @@ void QDmcpConnection::sendRequest(QDmcpRequest& request)
     /// `readResponse` signal, and the response to a write request will be sent to the `writeResponse` signal.
     /// </summary>
     /// <param name="request">The request to send to the RMC.</param>
-    request.m_data->m_transactionID = m_currentTransactionID++;
+    assignTransactionID(request);
     m_requests.append(request.m_data);
     request.write(m_dataStream);
 }
 
+bool QDmcpConnection::sendReadPlan(const QDmcpReadPlan& plan, QVariant associatedData)
+{
+    /// <summary>
+    /// Sends every range of a compiled read plan to the RMC. Once all of the ranges have been answered,
+    /// the `readPlanResponse` signal is fired once with the values in the order the plan's tags were
+    /// compiled in. If any range failed, the first failing response code is reported. An invalid plan
+    /// (one with unknown tags, or no tags at all) is rejected without sending anything.
+    /// </summary>
+    /// <param name="plan">The read plan to send, as compiled by `QDmcpTagDatabase::compileReadPlan`.</param>
+    /// <param name="associatedData">Data passed back unchanged with the response.</param>
+    /// <returns>Whether the plan was sent; if not, no `readPlanResponse` will follow.</returns>
+    if (!plan.m_unknownTags.isEmpty() || plan.m_ranges.isEmpty()) {
+        return false;
+    }
+
+    QSharedPointer<PendingPlanRead> pending(new PendingPlanRead);
+    pending->plan = plan;
+    pending->associatedData = associatedData;
+    pending->values = QSharedPointer<QVector<QVariant>>(new QVector<QVariant>(plan.m_tagNames.count()));
+    pending->remainingRanges = plan.m_ranges.count();
+    pending->responseCode = Success;
+
+    for (int i = 0; i < plan.m_ranges.count(); i++) {
+        // The request starts out sharing the plan's precomputed data; assigning the transaction ID in
+        // sendRequest detaches it into a copy, leaving the plan itself untouched for the next send.
+        QDmcpReadRequest request;
+        request.m_data = plan.m_ranges.at(i);
+        sendRequest(request);
+        m_planReads.insert(request.m_data.constData()->m_transactionID, qMakePair(pending, i));
+    }
+
+    return true;
+}
+
+void QDmcpConnection::sendStreamWrite(QDmcpWriteRequest& request, quint16 streamID)
+{
+    /// <summary>
+    /// Sends a write request to the RMC without a per-write response. The acknowledgement is tracked
+    /// internally: only failures are reported, via the `streamWriteFailed` signal, and the number of
+    /// successes and failures for each stream is reported every `streamReportInterval` milliseconds
+    /// via the `streamWriteCounts` signal.
+    /// </summary>
+    /// <param name="request">The write request to send to the RMC.</param>
+    /// <param name="streamID">The stream whose counts this write is reported under.</param>
+    quint16 transactionID = assignTransactionID(request);
+
+    // If the transaction ID has wrapped around to a write that was never acknowledged, count
+    // that write as failed before its entry is replaced.
+    auto unacknowledged = m_streamWrites.constFind(transactionID);
+    if (unacknowledged != m_streamWrites.constEnd()) {
+        m_streamCounts[unacknowledged->streamID].failures++;
+    }
+
+    m_streamWrites.insert(transactionID, StreamWrite { streamID, request.m_data->m_file, request.m_data->m_element });
+    request.write(m_dataStream);
+
+    if (!m_streamReportTimer->isActive()) {
+        m_streamReportTimer->start();
+    }
+}
+
+quint16 QDmcpConnection::assignTransactionID(QDmcpRequest& request)
+{
+    /// <summary>
+    /// Gives a request the next transaction ID, which its response will be matched against.
+    /// </summary>
+    /// <param name="request">The request about to be sent.</param>
+    /// <returns>The transaction ID assigned.</returns>
+    quint16 transactionID = m_currentTransactionID++;
+    request.m_data->m_transactionID = transactionID;
+    return transactionID;
+}
+
 void QDmcpConnection::onConnected()
 {
     /// <summary>
@@ -59,8 +137,36 @@ void QDmcpConnection::onDisconnected()
 {
     /// <summary>
     /// Run when the socket connection with the RMC is closed.
+    /// Requests still outstanding will never be answered, so they are dropped here; read plans
+    /// among them are finished with the `ConnectionLost` response code, and streamed writes among
+    /// them are counted as failures in a final `streamWriteCounts` report.
     /// </summary>
+    m_requests.clear();
+
+    for (const StreamWrite& streamWrite : m_streamWrites) {
+        m_streamCounts[streamWrite.streamID].failures++;
+    }
+    m_streamWrites.clear();
+    m_streamReportTimer->stop();
+    onStreamReportTimeout();
+
+    // Report the disconnection before failing the pending plans, so that their handlers already
+    // see the connection as closed.
     emit disconnected();
+
+    // Take the pending plans first, in case a handler sends a new plan while they are reported.
+    const QHash<quint16, QPair<QSharedPointer<PendingPlanRead>, int>> planReads = m_planReads;
+    m_planReads.clear();
+    for (const auto& planRead : planReads) {
+        QSharedPointer<PendingPlanRead> pending = planRead.first;
+        if (pending->remainingRanges > 0) {
+            pending->remainingRanges = 0;
+            if (pending->responseCode == Success) {
+                pending->responseCode = ConnectionLost;
+            }
+            emit readPlanResponse(pending->plan, pending->associatedData, pending->values, pending->responseCode);
+        }
+    }
 }
 
 void QDmcpConnection::onError(QAbstractSocket::SocketError error)
@@ -75,19 +181,64 @@ void QDmcpConnection::onDataReceived()
 {
     /// <summary>
     /// Run when data is received from the socket.
+    /// Several responses may arrive together (for example, when writes are streamed), so this handles
+    /// every complete response that is available, leaving a partial one for the next call.
+    /// </summary>
+    while (m_socket->bytesAvailable() >= static_cast<qint64>(sizeof(quint16))) {
+        // The packet length doesn't include the length field itself.
+        QByteArray lengthBytes = m_socket->peek(sizeof(quint16));
+        quint16 packetLength = qFromLittleEndian<quint16>(lengthBytes.constData());
+        if (m_socket->bytesAvailable() < packetLength + static_cast<qint64>(sizeof(quint16))) {
+            break;
+        }
+
+        // Take the whole packet off the socket before parsing it, so that a response that isn't
+        // fully parsed can't leave bytes behind to be mistaken for the next one.
+        processResponse(m_socket->read(packetLength + sizeof(quint16)));
+    }
+}
+
+void QDmcpConnection::processResponse(const QByteArray& packet)
+{
+    /// <summary>
+    /// Parses a single response read from the socket.
     /// This function determines which request the response is for, and emits a signal for the
     /// response of the corresponding type.
     /// </summary>
+    /// <param name="packet">The complete response packet, including its length field.</param>
+    QDataStream stream(packet);
+    stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::FloatingPointPrecision::SinglePrecision);
 
     quint16 packetLength, staticValues, transactionID;
     quint8 functionCode, responseCode;
 
-    // Read in raw data from the data stream to the header variables.
-    m_dataStream >> packetLength;
-    m_dataStream >> staticValues;
-    m_dataStream >> transactionID;
-    m_dataStream >> functionCode;
-    m_dataStream >> responseCode;
+    // Read in raw data from the packet to the header variables.
+    stream >> packetLength;
+    stream >> staticValues;
+    stream >> transactionID;
+    stream >> functionCode;
+    stream >> responseCode;
+
+    // Drop a packet too short to hold the header, rather than matching it to a transaction.
+    if (packetLength < 6 || stream.status() != QDataStream::Ok) {
+        return;
+    }
+
+    // Streamed writes are only counted, and reported individually if they failed.
+    auto streamWrite = m_streamWrites.find(transactionID);
+    if (streamWrite != m_streamWrites.end()) {
+        StreamCounts& counts = m_streamCounts[streamWrite->streamID];
+        if (responseCode == Success) {
+            counts.successes++;
+        } else {
+            counts.failures++;
+            emit streamWriteFailed(streamWrite->streamID, streamWrite->file, streamWrite->element, static_cast<QDmcpConnection::ResponseCode>(responseCode));
+        }
+
+        m_streamWrites.erase(streamWrite);
+        return;
+    }
 
     // Locate the QDmcpRequest item in the list of active requests
     for (int i = 0; i < m_requests.count(); i++) {
@@ -116,14 +267,34 @@ void QDmcpConnection::onDataReceived()
                 for (int i = 0; i < numberOfValues; i++) {
                     // Check what this value is supposed to be
                     if (thisRequestData->m_readTypes->at(i) == QMetaType::Float) {
-                        m_dataStream >> floatValue;
+                        stream >> floatValue;
                         values->append(QVariant(floatValue));
                     } else {
-                        m_dataStream >> intValue;
+                        stream >> intValue;
                         values->append(intValue);
                     }
                 }
 
+                // If this read was one range of a read plan, scatter its values into the plan's
+                // result, and emit the readPlanResponse signal once every range has been answered.
+                auto planRead = m_planReads.find(transactionID);
+                if (planRead != m_planReads.end()) {
+                    QSharedPointer<PendingPlanRead> pending = planRead->first;
+                    int rangeIndex = planRead->second;
+                    m_planReads.erase(planRead);
+
+                    if (responseCode == Success) {
+                        pending->plan.scatter(rangeIndex, *values, *pending->values);
+                    } else if (pending->responseCode == Success) {
+                        pending->responseCode = static_cast<QDmcpConnection::ResponseCode>(responseCode);
+                    }
+
+                    if (--pending->remainingRanges == 0) {
+                        emit readPlanResponse(pending->plan, pending->associatedData, pending->values, pending->responseCode);
+                    }
+                    break;
+                }
+
                 // Emit the readResponse signal with the original read request object, the QVector of values
                 // the request retrieved, and the response code.
                 QSharedPointer<QDmcpReadRequest> newRequest(new QDmcpReadRequest);
@@ -134,3 +305,19 @@ void QDmcpConnection::onDataReceived()
         }
     }
 }
+
+void QDmcpConnection::onStreamReportTimeout()
+{
+    /// <summary>
+    /// Run periodically while writes are being streamed. Reports the acknowledgements counted for each
+    /// stream since the last report, and stops once there is nothing left to report.
+    /// </summary>
+    for (auto i = m_streamCounts.constBegin(); i != m_streamCounts.constEnd(); ++i) {
+        emit streamWriteCounts(i.key(), i.value().successes, i.value().failures);
+    }
+
+    if (m_streamCounts.isEmpty() && m_streamWrites.isEmpty()) {
+        m_streamReportTimer->stop();
+    }
+    m_streamCounts.clear();
+}
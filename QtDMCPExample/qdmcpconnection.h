@@ -6,9 +6,12 @@
 #include <QAbstractSocket>
 #include <QTcpSocket>
 #include <QDataStream>
+#include <QHash>
+#include <QTimer>
 
 #include "qdmcpwriterequest.h"
 #include "qdmcpreadrequest.h"
+#include "qdmcpreadplan.h"
 
 class QDmcpConnection : public QObject
 {
@@ -20,6 +23,11 @@ public:
     void disconnectFromRMC();
 
     void sendRequest(QDmcpRequest& request);
+    bool sendReadPlan(const QDmcpReadPlan& plan, QVariant associatedData = QVariant());
+    void sendStreamWrite(QDmcpWriteRequest& request, quint16 streamID);
+
+    int streamReportInterval() { return m_streamReportTimer->interval(); }
+    void setStreamReportInterval(int msec) { m_streamReportTimer->setInterval(msec); }
 
     QString socketErrorString() { return m_socket->errorString(); }
     QTcpSocket::SocketState state() { return m_socket->state(); }
@@ -28,7 +36,10 @@ public:
         Success = 0x00,
         Malformed = 0x01,
         TooLong = 0x02,
-        InvalidAddress = 0x03
+        InvalidAddress = 0x03,
+
+        // Not sent by the RMC: reported for requests still outstanding when the connection closed.
+        ConnectionLost = 0xFF
     };
 
 private:
@@ -38,11 +49,44 @@ private:
 
     quint16 m_currentTransactionID = 0;
 
+    // A read plan whose ranges have not all been answered yet.
+    struct PendingPlanRead {
+        QDmcpReadPlan plan;
+        QVariant associatedData;
+        QSharedPointer<QVector<QVariant>> values;
+        int remainingRanges;
+        ResponseCode responseCode;
+    };
+
+    // Maps the transaction ID of each outstanding plan range to its plan and range index.
+    QHash<quint16, QPair<QSharedPointer<PendingPlanRead>, int>> m_planReads;
+
+    // What's needed to report on a streamed write without keeping its request around.
+    struct StreamWrite {
+        quint16 streamID;
+        quint16 file;
+        quint16 element;
+    };
+
+    struct StreamCounts {
+        quint32 successes = 0;
+        quint32 failures = 0;
+    };
+
+    // Outstanding streamed writes by transaction ID, and acknowledgements per stream since the last report.
+    QHash<quint16, StreamWrite> m_streamWrites;
+    QHash<quint16, StreamCounts> m_streamCounts;
+    QTimer *m_streamReportTimer;
+
+    quint16 assignTransactionID(QDmcpRequest& request);
+    void processResponse(const QByteArray& packet);
+
 private slots:
     void onConnected();
     void onDisconnected();
     void onError(QAbstractSocket::SocketError error);
     void onDataReceived();
+    void onStreamReportTimeout();
 
 signals:
     void connected();
@@ -50,6 +94,9 @@ signals:
     void socketErrorOccurred(QAbstractSocket::SocketError error);
     void readResponse(QDmcpReadRequest *request, QSharedPointer<QVector<QVariant>> values, QDmcpConnection::ResponseCode responseCode);
     void writeResponse(QDmcpWriteRequest *request, QDmcpConnection::ResponseCode responseCode);
+    void streamWriteFailed(quint16 streamID, quint16 file, quint16 element, QDmcpConnection::ResponseCode responseCode);
+    void streamWriteCounts(quint16 streamID, quint32 successes, quint32 failures);
+    void readPlanResponse(QDmcpReadPlan plan, QVariant associatedData, QSharedPointer<QVector<QVariant>> values, QDmcpConnection::ResponseCode responseCode);
 };
 
 #endif // QDMCPCONNECTION_H
@@ -0,0 +1,17 @@
+#include "qdmcpreadplan.h"
+
+void QDmcpReadPlan::scatter(int rangeIndex, const QVector<QVariant>& rangeValues, QVector<QVariant>& tagValues) const {
+    /// <summary>
+    /// Copies the values read for one of the plan's ranges into their places in the per-tag result.
+    /// </summary>
+    /// <param name="rangeIndex">The index of the range the values were read for.</param>
+    /// <param name="rangeValues">The values returned by the RMC for that range.</param>
+    /// <param name="tagValues">The per-tag result, in the order the tag names were compiled in.</param>
+    if (tagValues.count() < m_tagNames.count()) {
+        tagValues.resize(m_tagNames.count());
+    }
+
+    for (const ScatterEntry& entry : m_scatterMap.at(rangeIndex)) {
+        tagValues[entry.tag] = rangeValues.value(entry.offset);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef QDMCPREADPLAN_H
+#define QDMCPREADPLAN_H
+
+#include "qdmcprequest.h"
+
+#include <QStringList>
+#include <QVector>
+
+class QDmcpReadPlan
+{
+    friend class QDmcpConnection;
+    friend class QDmcpTagDatabase;
+
+public:
+    QDmcpReadPlan() {}
+
+    bool isValid() { return m_unknownTags.isEmpty() && !m_ranges.isEmpty(); }
+
+    QStringList tagNames() { return m_tagNames; }
+    QStringList unknownTags() { return m_unknownTags; }
+
+    int rangeCount() { return m_ranges.count(); }
+
+    void scatter(int rangeIndex, const QVector<QVariant>& rangeValues, QVector<QVariant>& tagValues) const;
+
+private:
+    // Where a single tag's value lives in the response to one of the plan's ranges.
+    struct ScatterEntry {
+        int tag;
+        int offset;
+    };
+
+    QStringList m_tagNames;
+    QStringList m_unknownTags;
+
+    // Precomputed read request data, one per merged address range. Each send copies it into a new
+    // request (sharing the read types), so the plan itself is never modified.
+    QVector<QSharedDataPointer<QDmcpRequestData>> m_ranges;
+
+    // For each range, the tags it carries values for.
+    QVector<QVector<ScatterEntry>> m_scatterMap;
+};
+
+#endif // QDMCPREADPLAN_H
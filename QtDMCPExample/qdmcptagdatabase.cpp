@@ -0,0 +1,184 @@
+#include "qdmcptagdatabase.h"
+
+#include <QFile>
+
+#include <algorithm>
+
+bool QDmcpTagDatabase::load(const QString& fileName)
+{
+    /// <summary>
+    /// Loads the tag table from a file, replacing any tags already loaded. Each non-empty line that
+    /// does not start with '#' has the form `name,file,element,type`, where type is one of
+    /// `float`, `real`, `int`, or `dint`. Tags may share an address only if they give it the same type.
+    /// On failure the reason is available from `errorString`.
+    /// </summary>
+    /// <param name="fileName">The path of the tag table to load.</param>
+    /// <returns>Whether the whole table was loaded.</returns>
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+
+    // Read the whole table in one go and reserve the hash up front, so that large tables don't
+    // pay for repeated small reads or rehashing.
+    const QByteArray contents = file.readAll();
+    QHash<QString, QDmcpTag> tags;
+    tags.reserve(contents.count('\n') + 1);
+
+    // The type each address has been given so far. Several tags may name the same register, but
+    // only with the same type, since a read plan decodes each register once.
+    QHash<quint32, QMetaType::Type> addressTypes;
+    addressTypes.reserve(tags.capacity());
+
+    int lineNumber = 0;
+    int lineStart = 0;
+    while (lineStart < contents.size()) {
+        int lineEnd = contents.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = contents.size();
+        }
+
+        const QByteArray line = contents.mid(lineStart, lineEnd - lineStart).trimmed();
+        lineStart = lineEnd + 1;
+        lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        const QList<QByteArray> fields = line.split(',');
+        if (fields.count() != 4) {
+            m_errorString = QString("Line %1: expected name,file,element,type").arg(lineNumber);
+            return false;
+        }
+
+        const QString name = QString::fromUtf8(fields.at(0).trimmed());
+        bool fileOk, elementOk;
+        QDmcpTag tag;
+        tag.file = fields.at(1).trimmed().toUShort(&fileOk);
+        tag.element = fields.at(2).trimmed().toUShort(&elementOk);
+
+        const QByteArray type = fields.at(3).trimmed().toLower();
+        if (type == "float" || type == "real") {
+            tag.type = QMetaType::Float;
+        } else if (type == "int" || type == "dint") {
+            tag.type = QMetaType::Int;
+        }
+
+        if (name.isEmpty() || !fileOk || !elementOk || tag.type == QMetaType::UnknownType) {
+            m_errorString = QString("Line %1: invalid tag definition").arg(lineNumber);
+            return false;
+        }
+
+        if (tags.contains(name)) {
+            m_errorString = QString("Line %1: duplicate tag \"%2\"").arg(lineNumber).arg(name);
+            return false;
+        }
+
+        const quint32 address = (static_cast<quint32>(tag.file) << 16) | tag.element;
+        auto addressType = addressTypes.constFind(address);
+        if (addressType != addressTypes.constEnd() && addressType.value() != tag.type) {
+            m_errorString = QString("Line %1: tag \"%2\" gives %3:%4 a different type than an earlier tag")
+                    .arg(lineNumber).arg(name).arg(tag.file).arg(tag.element);
+            return false;
+        }
+
+        addressTypes.insert(address, tag.type);
+        tags.insert(name, tag);
+    }
+
+    m_tags = tags;
+    m_errorString.clear();
+    return true;
+}
+
+QDmcpReadPlan QDmcpTagDatabase::compileReadPlan(const QStringList& tagNames, quint16 maxGap) const
+{
+    /// <summary>
+    /// Compiles a set of tag names into a reusable read plan. Tags are sorted by address and merged
+    /// into as few read requests as possible; registers that fall in a gap of up to `maxGap` between
+    /// two tags in the same file are read along with them rather than starting a new request.
+    /// The plan can then be sent any number of times with `QDmcpConnection::sendReadPlan`.
+    /// </summary>
+    /// <param name="tagNames">The tags to read, in the order their values should be reported.</param>
+    /// <param name="maxGap">The largest number of unused registers to read to avoid a new request.</param>
+    /// <returns>The compiled plan. If any tag was unknown, the plan is invalid and lists them.</returns>
+    QDmcpReadPlan plan;
+    plan.m_tagNames = tagNames;
+
+    struct Entry {
+        QDmcpTag tag;
+        int index;
+    };
+
+    QVector<Entry> entries;
+    entries.reserve(tagNames.count());
+    for (int i = 0; i < tagNames.count(); i++) {
+        auto it = m_tags.constFind(tagNames.at(i));
+        if (it == m_tags.constEnd()) {
+            plan.m_unknownTags.append(tagNames.at(i));
+        } else {
+            entries.append(Entry { it.value(), i });
+        }
+    }
+
+    if (!plan.m_unknownTags.isEmpty() || entries.isEmpty()) {
+        return plan;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.tag.file != b.tag.file) {
+            return a.tag.file < b.tag.file;
+        }
+        return a.tag.element < b.tag.element;
+    });
+
+    // Walk the tags in address order, growing the current range while the next tag is close enough
+    // and closing it off into a ready-to-send request otherwise.
+    quint16 rangeFile = 0;
+    int rangeStart = 0;
+    QVector<QMetaType::Type> rangeTypes;
+    QVector<QDmcpReadPlan::ScatterEntry> rangeScatter;
+
+    auto closeRange = [&]() {
+        QDmcpRequestData *data = new QDmcpRequestData;
+        data->m_transactionID = 0;
+        data->m_file = rangeFile;
+        data->m_element = static_cast<quint16>(rangeStart);
+        data->m_readCount = static_cast<quint16>(rangeTypes.count());
+        data->m_readTypes = QSharedPointer<QVector<QMetaType::Type>>(new QVector<QMetaType::Type>(rangeTypes));
+        plan.m_ranges.append(QSharedDataPointer<QDmcpRequestData>(data));
+        plan.m_scatterMap.append(rangeScatter);
+        rangeTypes.clear();
+        rangeScatter.clear();
+    };
+
+    for (const Entry& entry : entries) {
+        const int element = entry.tag.element;
+        const int rangeEnd = rangeStart + rangeTypes.count();
+
+        bool extendsRange = !rangeTypes.isEmpty()
+                && entry.tag.file == rangeFile
+                && element - rangeEnd <= maxGap
+                && element - rangeStart < MaxRangeLength;
+
+        if (!extendsRange) {
+            if (!rangeTypes.isEmpty()) {
+                closeRange();
+            }
+            rangeFile = entry.tag.file;
+            rangeStart = element;
+        }
+
+        // Registers skipped over in a gap are read as integers and ignored.
+        while (rangeStart + rangeTypes.count() <= element) {
+            rangeTypes.append(QMetaType::Int);
+        }
+        rangeTypes[element - rangeStart] = entry.tag.type;
+        rangeScatter.append(QDmcpReadPlan::ScatterEntry { entry.index, element - rangeStart });
+    }
+    closeRange();
+
+    return plan;
+}
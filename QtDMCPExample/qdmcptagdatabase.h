@@ -0,0 +1,38 @@
+#ifndef QDMCPTAGDATABASE_H
+#define QDMCPTAGDATABASE_H
+
+#include "qdmcpreadplan.h"
+
+#include <QHash>
+#include <QString>
+
+struct QDmcpTag
+{
+    quint16 file = 0;
+    quint16 element = 0;
+    QMetaType::Type type = QMetaType::UnknownType;
+};
+
+class QDmcpTagDatabase
+{
+public:
+    QDmcpTagDatabase() {}
+
+    // The most registers a single merged range may span.
+    static const quint16 MaxRangeLength = 256;
+
+    bool load(const QString& fileName);
+    QString errorString() { return m_errorString; }
+
+    int count() { return m_tags.count(); }
+    bool contains(const QString& name) { return m_tags.contains(name); }
+    QDmcpTag tag(const QString& name) { return m_tags.value(name); }
+
+    QDmcpReadPlan compileReadPlan(const QStringList& tagNames, quint16 maxGap = 8) const;
+
+private:
+    QHash<QString, QDmcpTag> m_tags;
+    QString m_errorString;
+};
+
+#endif // QDMCPTAGDATABASE_H
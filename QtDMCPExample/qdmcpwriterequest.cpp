@@ -43,11 +43,9 @@ const void QDmcpWriteRequest::write(QDataStream& stream) {
         QVariant v = i.next();
         if (v.type() == QMetaType::Float) {
             float value = v.value<float>();
-            qDebug() << value;
             stream << value;
         } else {
             qint32 value = v.value<qint32>();
-            qDebug() << value;
             stream << value;
         }
     }